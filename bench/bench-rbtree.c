@@ -0,0 +1,383 @@
+#include "../src/rbtree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// keeps the compiler from dropping scans whose result is unused
+static volatile key_t sink;
+
+static rbtree *build_rand(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  for (size_t i = 0; i < n; i++) {
+    rbtree_insert(t, rand());
+  }
+  return t;
+}
+
+// speedup of the parallel to_array/delete/check against the serial versions
+static void bench_parallel(const size_t n) {
+  const int threads[] = {1, 2, 4, 8, 16};
+  key_t *arr = calloc(n, sizeof(key_t));
+  rbtree *t = build_rand(n, 17);
+
+  double start = now();
+  rbtree_to_array(t, arr, n);
+  const double serial_to_array = now() - start;
+  start = now();
+  rbtree_check(t);
+  const double serial_check = now() - start;
+  start = now();
+  delete_rbtree(t);
+  const double serial_delete = now() - start;
+
+  printf("parallel: n=%zu, serial to_array %.3fs check %.3fs delete %.3fs\n", n,
+         serial_to_array, serial_check, serial_delete);
+  printf("%8s %10s %10s %10s\n", "threads", "to_array", "check", "delete");
+  for (int i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    t = build_rand(n, 17);
+    start = now();
+    rbtree_to_array_parallel(t, arr, n, threads[i]);
+    const double to_array = now() - start;
+    start = now();
+    rbtree_check_parallel(t, threads[i]);
+    const double check = now() - start;
+    start = now();
+    delete_rbtree_parallel(t, threads[i]);
+    const double delete = now() - start;
+    printf("%8d %9.2fx %9.2fx %9.2fx\n", threads[i], serial_to_array / to_array,
+           serial_check / check, serial_delete / delete);
+  }
+  free(arr);
+}
+
+static size_t depth(const rbtree *t, const node_t *node) {
+  size_t d = 0;
+  for (; node->parent != t->nil; node = node->parent) {
+    d++;
+  }
+  return d;
+}
+
+// number of edges on the tree path between a and b
+static size_t distance(const rbtree *t, const node_t *a, const node_t *b) {
+  size_t da = depth(t, a), db = depth(t, b), d = 0;
+  for (; da > db; da--, d++) {
+    a = a->parent;
+  }
+  for (; db > da; db--, d++) {
+    b = b->parent;
+  }
+  for (; a != b; d += 2) {
+    a = a->parent;
+    b = b->parent;
+  }
+  return d;
+}
+
+// rbtree_insert/rbtree_find against the hinted versions, with the last
+// inserted/found node as the hint
+static void bench_hint(const size_t n) {
+  const char *streams[] = {"sequential", "nearly-sorted", "random"};
+  key_t *keys = calloc(n, sizeof(key_t));
+
+  printf("hint: n=%zu, ns per operation (nodes on the search path per insert)\n", n);
+  printf("%14s %10s %12s %10s %10s %8s %8s\n", "stream", "insert", "insert_hint",
+         "find", "find_near", "path", "path_hint");
+  for (int s = 0; s < 3; s++) {
+    srand(31);
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = s == 0 ? i : s == 1 ? i + rand() % 64 : rand();
+    }
+
+    rbtree *t = new_rbtree();
+    double start = now();
+    for (size_t i = 0; i < n; i++) {
+      rbtree_insert(t, keys[i]);
+    }
+    const double insert = now() - start;
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      rbtree_find(t, keys[i]);
+    }
+    const double find = now() - start;
+    delete_rbtree(t);
+
+    t = new_rbtree();
+    node_t *hint = NULL;
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      hint = rbtree_insert_hint(t, hint, keys[i]);
+    }
+    const double insert_hint = now() - start;
+    hint = NULL;
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      hint = rbtree_find_near(t, hint, keys[i]);
+    }
+    const double find_near = now() - start;
+    delete_rbtree(t);
+
+    // untimed rebuilds: tree distance from the search's starting point (root
+    // or hint) to each new node, measured right after its insert
+    size_t path = 0, path_hint = 0;
+    t = new_rbtree();
+    for (size_t i = 0; i < n; i++) {
+      path += distance(t, t->root, rbtree_insert(t, keys[i]));
+    }
+    delete_rbtree(t);
+    t = new_rbtree();
+    hint = NULL;
+    for (size_t i = 0; i < n; i++) {
+      node_t *p = rbtree_insert_hint(t, hint, keys[i]);
+      path_hint += hint == NULL ? 0 : distance(t, hint, p);
+      hint = p;
+    }
+    delete_rbtree(t);
+
+    printf("%14s %10.1f %12.1f %10.1f %10.1f %8.1f %8.1f\n", streams[s],
+           insert * 1e9 / n, insert_hint * 1e9 / n, find * 1e9 / n,
+           find_near * 1e9 / n, (double)path / n, (double)path_hint / n);
+  }
+  free(keys);
+}
+
+// insert/find/erase throughput and memory with the hash index on and off,
+// for distinct keys and for a multiset of only 4 distinct keys
+static void bench_index(const size_t n) {
+  const char *key_sets[] = {"distinct", "4 keys"};
+  key_t *keys = calloc(n, sizeof(key_t));
+  node_t **nodes = calloc(n, sizeof(node_t *));
+
+  printf("index: n=%zu\n", n);
+  printf("%9s %6s %14s %14s %14s %16s\n", "keys", "index", "insert Mops/s",
+         "find Mops/s", "erase Mops/s", "index bytes/key");
+  for (int k = 0; k < 2; k++) {
+    srand(59);
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = k == 0 ? rand() : rand() % 4;
+    }
+    for (int indexed = 0; indexed < 2; indexed++) {
+      rbtree *t = new_rbtree();
+      if (indexed) {
+        rbtree_index_enable(t);
+      }
+      double start = now();
+      for (size_t i = 0; i < n; i++) {
+        nodes[i] = rbtree_insert(t, keys[i]);
+      }
+      const double insert = now() - start;
+      start = now();
+      key_t sum = 0;
+      for (size_t i = 0; i < n; i++) {
+        sum += rbtree_find(t, keys[(i * 7919) % n])->key;
+      }
+      const double find = now() - start;
+      sink = sum;
+      const size_t memory = rbtree_index_memory(t);
+      start = now();
+      for (size_t i = 0; i < n; i++) {
+        rbtree_erase(t, nodes[(i * 7919) % n]);
+      }
+      const double erase = now() - start;
+      printf("%9s %6s %14.2f %14.2f %14.2f %16.1f\n", key_sets[k],
+             indexed ? "on" : "off", n / insert / 1e6, n / find / 1e6,
+             n / erase / 1e6, (double)memory / n);
+      delete_rbtree(t);
+    }
+  }
+  printf("(each node_t is %zu bytes plus malloc overhead)\n", sizeof(node_t));
+  free(nodes);
+  free(keys);
+}
+
+static int comp(const void *p1, const void *p2) {
+  const key_t e1 = *(const key_t *)p1, e2 = *(const key_t *)p2;
+  return (e1 > e2) - (e1 < e2);
+}
+
+// merged cursor against to_array on every tree + qsort of the concatenation,
+// for a full ordered scan and for the first 100 keys after a seek
+static void bench_merge(const size_t n) {
+  key_t *arr = calloc(n, sizeof(key_t));
+
+  printf("merge: n=%zu keys in total, ms per query\n", n);
+  printf("%6s %12s %12s %12s %12s\n", "trees", "concat+sort", "cursor",
+         "sort top100", "cursor top100");
+  for (size_t ntrees = 2; ntrees <= 256; ntrees *= 2) {
+    srand(47);
+    rbtree **trees = calloc(ntrees, sizeof(rbtree *));
+    for (size_t i = 0; i < ntrees; i++) {
+      trees[i] = new_rbtree();
+    }
+    for (size_t i = 0; i < n; i++) {
+      rbtree_insert(trees[i % ntrees], rand());
+    }
+    const key_t from = RAND_MAX / 2;
+
+    double start = now();
+    size_t off = 0;
+    for (size_t i = 0; i < ntrees; i++) {
+      rbtree_to_array(trees[i], arr + off, n - off);
+      off += (n - i - 1) / ntrees + 1;
+    }
+    qsort(arr, n, sizeof(key_t), comp);
+    const double sort = now() - start;
+    // the baseline has to sort everything before it can answer a range query
+    start = now();
+    off = 0;
+    for (size_t i = 0; i < ntrees; i++) {
+      rbtree_to_array(trees[i], arr + off, n - off);
+      off += (n - i - 1) / ntrees + 1;
+    }
+    qsort(arr, n, sizeof(key_t), comp);
+    size_t lo = 0;
+    while (lo < n && arr[lo] < from) {
+      lo++;
+    }
+    const double sort_top = now() - start;
+
+    start = now();
+    rbtree_cursor *c = rbtree_cursor_open(trees, ntrees);
+    key_t sum = 0;
+    for (node_t *p = rbtree_cursor_next(c, NULL); p != NULL;
+         p = rbtree_cursor_next(c, NULL)) {
+      sum += p->key;
+    }
+    const double cursor = now() - start;
+    start = now();
+    rbtree_cursor_seek(c, from);
+    for (int i = 0; i < 100; i++) {
+      node_t *p = rbtree_cursor_next(c, NULL);
+      sum += p ? p->key : 0;
+    }
+    rbtree_cursor_close(c);
+    const double cursor_top = now() - start;
+
+    sink = sum + arr[lo < n ? lo : 0];
+    printf("%6zu %12.3f %12.3f %12.3f %12.3f\n", ntrees, sort * 1e3,
+           cursor * 1e3, sort_top * 1e3, cursor_top * 1e3);
+    for (size_t i = 0; i < ntrees; i++) {
+      delete_rbtree(trees[i]);
+    }
+    free(trees);
+  }
+  free(arr);
+}
+
+// write throughput with and without the write buffer, and the read-side
+// cost of consulting it
+static void bench_buffer(const size_t n) {
+  const size_t caps[] = {0, 64, 256, 1024};
+  key_t *keys = calloc(n, sizeof(key_t));
+  srand(67);
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = rand();
+  }
+
+  printf("buffer: n=%zu, ns per operation (capacity 0 = unbuffered)\n", n);
+  printf("%8s %10s %10s %12s %10s %10s\n", "capacity", "insert", "churn",
+         "short-lived", "find", "90w/10r");
+  for (int c = 0; c < sizeof(caps) / sizeof(caps[0]); c++) {
+    // write burst: n random inserts, then the final flush
+    rbtree *t = new_rbtree();
+    if (caps[c]) {
+      rbtree_buffer_enable(t, caps[c]);
+    }
+    double start = now();
+    for (size_t i = 0; i < n; i++) {
+      rbtree_buffer_insert(t, keys[i]);
+    }
+    rbtree_flush(t);
+    const double insert = now() - start;
+
+    // churn: every insert is paired with an erase of an older key
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      rbtree_buffer_insert(t, keys[i] ^ 1);
+      rbtree_buffer_erase(t, keys[(i * 7919) % n]);
+    }
+    rbtree_flush(t);
+    const double churn = now() - start;
+
+    // short-lived keys: erased 8 operations after their insert
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      rbtree_buffer_insert(t, keys[i] + 1);
+      if (i >= 8) {
+        rbtree_buffer_erase(t, keys[i - 8] + 1);
+      }
+    }
+    rbtree_flush(t);
+    const double short_lived = now() - start;
+
+    // reads of keys that are not buffered, with the buffer half full
+    for (size_t i = 0; i < caps[c] / 2; i++) {
+      rbtree_buffer_insert(t, keys[i] + 2);
+    }
+    key_t sum = 0;
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      node_t *p = rbtree_find(t, keys[(i * 7919) % n] ^ 1);
+      sum += p ? p->key : 0;
+    }
+    const double find = now() - start;
+    delete_rbtree(t);
+
+    // mixed: a read of a buffered key forces a flush
+    t = new_rbtree();
+    if (caps[c]) {
+      rbtree_buffer_enable(t, caps[c]);
+    }
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      if (i % 10 == 9) {
+        node_t *p = rbtree_find(t, keys[i - 1]);
+        sum += p ? p->key : 0;
+      } else {
+        rbtree_buffer_insert(t, keys[i]);
+      }
+    }
+    const double mixed = now() - start;
+    delete_rbtree(t);
+    sink = sum;
+
+    printf("%8zu %10.1f %10.1f %12.1f %10.1f %10.1f\n", caps[c],
+           insert * 1e9 / n, churn * 1e9 / n, short_lived * 1e9 / n,
+           find * 1e9 / n, mixed * 1e9 / n);
+  }
+  free(keys);
+}
+
+typedef struct {
+  const char *name;
+  void (*run)(const size_t);
+  size_t default_n;
+} bench_t;
+
+static const bench_t benches[] = {
+    {"parallel", bench_parallel, 1000000},
+    {"hint", bench_hint, 1000000},
+    {"merge", bench_merge, 1000000},
+    {"index", bench_index, 1000000},
+    {"buffer", bench_buffer, 1000000},
+};
+
+int main(int argc, char *argv[]) {
+  const size_t nbench = sizeof(benches) / sizeof(benches[0]);
+  for (size_t i = 0; i < nbench; i++) {
+    if (argc > 1 && strcmp(argv[1], benches[i].name) != 0) {
+      continue;
+    }
+    size_t n = argc > 2 ? strtoull(argv[2], NULL, 10) : benches[i].default_n;
+    benches[i].run(n);
+  }
+  return 0;
+}
@@ -0,0 +1,550 @@
+#include "../src/rbtree.h"
+#include <linux/perf_event.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Performance regression suite
+//
+// 1. differential fuzzer: random insert/erase/find sequences checked against
+//    a sorted array holding the same multiset
+// 2. per-operation hardware counters and wall time for tree sizes 10^3 ..
+//    max_n, compared against a baseline file. Every size is warmed up once
+//    and then sampled several times; the median sample is kept so that
+//    noisy runs do not fail the gate.
+
+/*
+ * PRNG (xorshift64*): reproducible across libc versions
+ */
+
+static uint64_t rng_state;
+
+static void rng_seed(const uint64_t seed) { rng_state = seed * 2 + 1; }
+
+static uint64_t rng_next(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return rng_state * 2685821657736338717ULL;
+}
+
+static uint64_t rng_below(const uint64_t n) { return rng_next() % n; }
+
+/*
+ * Differential fuzzer
+ */
+
+typedef struct {
+  key_t *keys;  // sorted
+  size_t n, cap;
+} oracle_t;
+
+// index of the first key >= key
+static size_t oracle_lower_bound(const oracle_t *o, const key_t key) {
+  size_t lo = 0, hi = o->n;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (o->keys[mid] < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static void oracle_insert(oracle_t *o, const key_t key) {
+  if (o->n == o->cap) {
+    o->cap = o->cap ? o->cap * 2 : 1024;
+    o->keys = realloc(o->keys, o->cap * sizeof(key_t));
+  }
+  size_t i = oracle_lower_bound(o, key);
+  memmove(o->keys + i + 1, o->keys + i, (o->n - i) * sizeof(key_t));
+  o->keys[i] = key;
+  o->n++;
+}
+
+static bool oracle_contains(const oracle_t *o, const key_t key) {
+  size_t i = oracle_lower_bound(o, key);
+  return i < o->n && o->keys[i] == key;
+}
+
+static void oracle_erase(oracle_t *o, const key_t key) {
+  size_t i = oracle_lower_bound(o, key);
+  memmove(o->keys + i, o->keys + i + 1, (o->n - i - 1) * sizeof(key_t));
+  o->n--;
+}
+
+static unsigned long long fuzz_seed;
+static size_t fuzz_step;
+
+#define FUZZ_CHECK(cond)                                                      \
+  do {                                                                        \
+    if (!(cond)) {                                                            \
+      fprintf(stderr, "fuzz: %s failed at step %zu (seed %llu)\n", #cond,     \
+              fuzz_step, fuzz_seed);                                          \
+      exit(1);                                                                \
+    }                                                                         \
+  } while (0)
+
+static void fuzz_compare(rbtree *t, const oracle_t *o) {
+  FUZZ_CHECK(rbtree_check(t));
+  if (o->n == 0) {
+    FUZZ_CHECK(t->root == t->nil);
+    return;
+  }
+  key_t *buf = malloc(o->n * sizeof(key_t));
+  rbtree_to_array(t, buf, o->n);
+  FUZZ_CHECK(memcmp(buf, o->keys, o->n * sizeof(key_t)) == 0);
+  free(buf);
+}
+
+typedef enum { FUZZ_PLAIN, FUZZ_INDEXED, FUZZ_BUFFERED } fuzz_mode_t;
+
+// one phase: keys drawn from [0, key_range), tree size wanders around max_size
+static void fuzz_phase(const size_t ops, const key_t key_range,
+                       const size_t max_size, const fuzz_mode_t mode) {
+  rbtree *t = new_rbtree();
+  if (mode == FUZZ_INDEXED) {
+    rbtree_index_enable(t);
+  } else if (mode == FUZZ_BUFFERED) {
+    rbtree_buffer_enable(t, 32);
+  }
+  oracle_t o = {NULL, 0, 0};
+  node_t *hint = NULL;
+
+  for (size_t i = 0; i < ops; i++, fuzz_step++) {
+    const uint64_t op = rng_below(100);
+    // erases and finds mostly target keys that are present
+    const key_t key = o.n > 0 && op % 4 != 0 ? o.keys[rng_below(o.n)]
+                                             : (key_t)rng_below(key_range);
+    // bias towards erase while the tree is large so the fixups of both
+    // insert and erase keep running
+    const bool grow = o.n < max_size ? op < 55 : op < 40;
+
+    if (mode == FUZZ_BUFFERED && grow && op % 2 == 0) {
+      // a buffered erase may free any node with the key, so no hints here
+      rbtree_buffer_insert(t, key);
+      oracle_insert(&o, key);
+    } else if (mode == FUZZ_BUFFERED && !grow && op % 2 == 0) {
+      const bool present = oracle_contains(&o, key);
+      FUZZ_CHECK((rbtree_buffer_erase(t, key) == 0) == present);
+      if (present) {
+        oracle_erase(&o, key);
+      }
+    } else if (grow && op % 5 == 0 && mode != FUZZ_BUFFERED) {
+      hint = rbtree_insert_hint(t, hint, key);
+      FUZZ_CHECK(hint != NULL && hint->key == key);
+      oracle_insert(&o, key);
+    } else if (grow) {
+      node_t *p = rbtree_insert(t, key);
+      FUZZ_CHECK(p != NULL && p->key == key);
+      oracle_insert(&o, key);
+    } else if (op < 90) {
+      node_t *p = op % 3 == 0 ? rbtree_find_near(t, hint, key)
+                              : rbtree_find(t, key);
+      FUZZ_CHECK((p != NULL) == oracle_contains(&o, key));
+      if (p != NULL) {
+        FUZZ_CHECK(p->key == key);
+        if (p == hint) {
+          hint = NULL;
+        }
+        rbtree_erase(t, p);
+        oracle_erase(&o, key);
+      }
+    } else {
+      node_t *p = rbtree_find(t, key);
+      FUZZ_CHECK((p != NULL) == oracle_contains(&o, key));
+      node_t *min = rbtree_min(t), *max = rbtree_max(t);
+      FUZZ_CHECK((min == NULL) == (o.n == 0));
+      if (o.n > 0) {
+        FUZZ_CHECK(min->key == o.keys[0] && max->key == o.keys[o.n - 1]);
+      }
+    }
+
+    if (i % 1024 == 0) {
+      fuzz_compare(t, &o);
+    }
+  }
+  fuzz_compare(t, &o);
+
+  free(o.keys);
+  delete_rbtree(t);
+}
+
+static void fuzz(const size_t ops) {
+  rng_seed(fuzz_seed);
+  fuzz_step = 0;
+  // many duplicates, small tree: every fixup case is hit constantly
+  fuzz_phase(ops / 4, 16, 64, FUZZ_PLAIN);
+  // some duplicates, medium tree
+  fuzz_phase(ops / 4, 1024, 1024, FUZZ_PLAIN);
+  // mostly distinct keys, larger tree
+  fuzz_phase(ops / 4, 1 << 30, 8192, FUZZ_PLAIN);
+  // same with the hash index maintained alongside the tree
+  fuzz_phase(ops / 8, 1024, 1024, FUZZ_INDEXED);
+  // buffered inserts/erases with tombstones
+  fuzz_phase(ops / 16, 16, 64, FUZZ_BUFFERED);
+  fuzz_phase(ops / 16, 1024, 1024, FUZZ_BUFFERED);
+  printf("fuzz: %zu operations matched the oracle (seed %llu)\n", fuzz_step,
+         fuzz_seed);
+}
+
+/*
+ * Hardware counters
+ */
+
+typedef struct {
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+  double threshold;  // allowed regression in percent
+} metric_t;
+
+#define L1D_READ_MISS                                                         \
+  (PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |             \
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+// metrics[0] is wall time, the rest are perf_event counters
+static const metric_t metrics[] = {
+    {"ns", 0, 0, 25},
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 15},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 5},
+    {"l1d-misses", PERF_TYPE_HW_CACHE, L1D_READ_MISS, 25},
+    {"llc-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 25},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 15},
+};
+#define NMETRICS (sizeof(metrics) / sizeof(metrics[0]))
+
+static int counter_fd[NMETRICS];
+
+static void counters_open(void) {
+  counter_fd[0] = -1;
+  for (int i = 1; i < NMETRICS; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = metrics[i].type;
+    attr.config = metrics[i].config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    counter_fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (counter_fd[i] < 0) {
+      fprintf(stderr, "perf: %s counter unavailable, skipped\n",
+              metrics[i].name);
+    }
+  }
+}
+
+static void counters_close(void) {
+  for (int i = 1; i < NMETRICS; i++) {
+    if (counter_fd[i] >= 0) {
+      close(counter_fd[i]);
+    }
+  }
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double start_time;
+
+static void counters_start(void) {
+  for (int i = 1; i < NMETRICS; i++) {
+    if (counter_fd[i] >= 0) {
+      ioctl(counter_fd[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  start_time = now();
+}
+
+// adds the elapsed ns and the counts since counters_start to totals
+static void counters_stop(double *totals) {
+  totals[0] += (now() - start_time) * 1e9;
+  for (int i = 1; i < NMETRICS; i++) {
+    uint64_t count;
+    if (counter_fd[i] < 0) {
+      continue;
+    }
+    ioctl(counter_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    if (read(counter_fd[i], &count, sizeof(count)) == sizeof(count)) {
+      totals[i] += count;
+    }
+  }
+}
+
+/*
+ * Measurements and baseline
+ */
+
+typedef struct {
+  char op[16];
+  size_t n;
+  double values[NMETRICS];
+} result_t;
+
+static result_t *results;
+static size_t nresults;
+
+static double *record(const char *op, const size_t n) {
+  results = realloc(results, (nresults + 1) * sizeof(result_t));
+  result_t *r = &results[nresults++];
+  snprintf(r->op, sizeof(r->op), "%s", op);
+  r->n = n;
+  return r->values;
+}
+
+enum { OP_INSERT, OP_FIND, OP_TO_ARRAY, OP_ERASE, NOPS };
+static const char *op_names[NOPS] = {"insert", "find", "to_array", "erase"};
+
+// every sample times at least this many operations per op type, so small
+// trees are built and torn down several times per sample
+#define MIN_SAMPLE_OPS 200000
+
+// one insert/find/to_array/erase cycle on a tree of n keys
+static void run_cycle(const key_t *keys, key_t *out, node_t **nodes,
+                      const size_t n, double totals[NOPS][NMETRICS]) {
+  rbtree *t = new_rbtree();
+  counters_start();
+  for (size_t i = 0; i < n; i++) {
+    nodes[i] = rbtree_insert(t, keys[i]);
+  }
+  counters_stop(totals[OP_INSERT]);
+
+  counters_start();
+  for (size_t i = 0; i < n; i++) {
+    rbtree_find(t, keys[(i * 7919) % n]);
+  }
+  counters_stop(totals[OP_FIND]);
+
+  counters_start();
+  rbtree_to_array(t, out, n);
+  counters_stop(totals[OP_TO_ARRAY]);
+
+  // erase in an order unrelated to insertion order
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = rng_below(i + 1);
+    node_t *tmp = nodes[i];
+    nodes[i] = nodes[j];
+    nodes[j] = tmp;
+  }
+  counters_start();
+  for (size_t i = 0; i < n; i++) {
+    rbtree_erase(t, nodes[i]);
+  }
+  counters_stop(totals[OP_ERASE]);
+
+  delete_rbtree(t);
+}
+
+static int compare_double(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// records, per op and metric, the median of reps samples after one warm-up
+static void measure(const size_t n, const int reps) {
+  key_t *keys = malloc(n * sizeof(key_t));
+  key_t *out = malloc(n * sizeof(key_t));
+  node_t **nodes = malloc(n * sizeof(node_t *));
+  double *samples = malloc(NOPS * NMETRICS * reps * sizeof(double));
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = rng_next() & 0x7fffffff;
+  }
+  const size_t rounds = (MIN_SAMPLE_OPS + n - 1) / n;
+  double totals[NOPS][NMETRICS];
+
+  // the warm-up cycle is not recorded
+  memset(totals, 0, sizeof(totals));
+  run_cycle(keys, out, nodes, n, totals);
+
+  for (int r = 0; r < reps; r++) {
+    memset(totals, 0, sizeof(totals));
+    for (size_t round = 0; round < rounds; round++) {
+      run_cycle(keys, out, nodes, n, totals);
+    }
+    for (int op = 0; op < NOPS; op++) {
+      for (int m = 0; m < NMETRICS; m++) {
+        samples[(op * NMETRICS + m) * reps + r] = totals[op][m] / (n * rounds);
+      }
+    }
+  }
+
+  for (int op = 0; op < NOPS; op++) {
+    double *values = record(op_names[op], n);
+    for (int m = 0; m < NMETRICS; m++) {
+      double *s = samples + (op * NMETRICS + m) * reps;
+      qsort(s, reps, sizeof(double), compare_double);
+      values[m] = m == 0 || counter_fd[m] >= 0
+                  ? (s[(reps - 1) / 2] + s[reps / 2]) / 2
+                  : -1;
+    }
+  }
+
+  free(samples);
+  free(nodes);
+  free(out);
+  free(keys);
+}
+
+static void print_results(void) {
+  printf("%-9s %10s", "op", "n");
+  for (int m = 0; m < NMETRICS; m++) {
+    printf(" %13s", metrics[m].name);
+  }
+  printf("\n");
+  for (size_t i = 0; i < nresults; i++) {
+    printf("%-9s %10zu", results[i].op, results[i].n);
+    for (int m = 0; m < NMETRICS; m++) {
+      if (results[i].values[m] < 0) {
+        printf(" %13s", "-");
+      } else {
+        printf(" %13.2f", results[i].values[m]);
+      }
+    }
+    printf("\n");
+  }
+}
+
+// baseline format: one "<op> <n> <metric> <value per op>" per line
+static int write_baseline(const char *path) {
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    perror(path);
+    return 1;
+  }
+  for (size_t i = 0; i < nresults; i++) {
+    for (int m = 0; m < NMETRICS; m++) {
+      if (results[i].values[m] >= 0) {
+        fprintf(fp, "%s %zu %s %.4f\n", results[i].op, results[i].n,
+                metrics[m].name, results[i].values[m]);
+      }
+    }
+  }
+  fclose(fp);
+  printf("perf: baseline written to %s\n", path);
+  return 0;
+}
+
+static int compare_baseline(const char *path, const double threshold) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    printf("perf: no baseline at %s, run `make perf-baseline` first "
+           "(or pass -S to skip the comparison)\n",
+           path);
+    return 1;
+  }
+
+  char op[16], name[32];
+  size_t n;
+  double base;
+  int regressions = 0, compared = 0, missing = 0;
+  bool *matched = calloc(nresults, sizeof(bool));
+  while (fscanf(fp, "%15s %zu %31s %lf", op, &n, name, &base) == 4) {
+    for (size_t i = 0; i < nresults; i++) {
+      if (strcmp(results[i].op, op) != 0 || results[i].n != n) {
+        continue;
+      }
+      matched[i] = true;
+      for (int m = 0; m < NMETRICS; m++) {
+        const double value = results[i].values[m];
+        if (strcmp(metrics[m].name, name) != 0 || value < 0 || base <= 0) {
+          continue;
+        }
+        const double limit = threshold >= 0 ? threshold : metrics[m].threshold;
+        const double change = (value - base) * 100 / base;
+        compared++;
+        if (change > limit) {
+          printf("REGRESSION %s n=%zu %s: %.2f -> %.2f (+%.1f%% > %.0f%%)\n",
+                 op, n, name, base, value, change, limit);
+          regressions++;
+        }
+      }
+    }
+  }
+  fclose(fp);
+
+  // a measured size the baseline does not cover would otherwise pass unchecked
+  for (size_t i = 0; i < nresults; i++) {
+    if (!matched[i]) {
+      printf("MISSING %s n=%zu: no baseline line\n", results[i].op,
+             results[i].n);
+      missing++;
+    }
+  }
+  free(matched);
+
+  printf("perf: %d of %d metrics regressed against %s\n", regressions,
+         compared, path);
+  if (compared == 0 || missing > 0) {
+    printf("perf: baseline %s does not cover this run (%d of %zu rows "
+           "missing), re-run `make perf-baseline` with the same PERF_MAX_N\n",
+           path, missing, nresults);
+    return 1;
+  }
+  return regressions > 0;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [-n max_n] [-f fuzz_ops] [-s seed] [-b baseline] "
+          "[-t threshold%%] [-k samples] [-r | -S]\n"
+          "  -r  record the baseline instead of comparing against it\n"
+          "  -S  skip the baseline comparison\n",
+          prog);
+  exit(2);
+}
+
+int main(int argc, char *argv[]) {
+  size_t max_n = 1000000, fuzz_ops = 1000000;
+  const char *baseline = "perf-baseline.txt";
+  double threshold = -1;  // per-metric defaults
+  bool record_baseline = false, skip_baseline = false;
+  int reps = 5;
+  int opt;
+
+  fuzz_seed = 1;
+  while ((opt = getopt(argc, argv, "n:f:s:b:t:k:rS")) != -1) {
+    switch (opt) {
+      case 'n': max_n = strtoull(optarg, NULL, 10); break;
+      case 'f': fuzz_ops = strtoull(optarg, NULL, 10); break;
+      case 's': fuzz_seed = strtoull(optarg, NULL, 10); break;
+      case 'b': baseline = optarg; break;
+      case 't': threshold = strtod(optarg, NULL); break;
+      case 'k': reps = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+      case 'r': record_baseline = true; break;
+      case 'S': skip_baseline = true; break;
+      default: usage(argv[0]);
+    }
+  }
+
+  fuzz(fuzz_ops);
+
+  counters_open();
+  rng_seed(42);
+  for (size_t n = 1000; n <= max_n; n *= 10) {
+    measure(n, reps);
+  }
+  counters_close();
+  print_results();
+
+  int ret = 0;
+  if (record_baseline) {
+    ret = write_baseline(baseline);
+  } else if (!skip_baseline) {
+    ret = compare_baseline(baseline, threshold);
+  }
+  free(results);
+  return ret;
+}
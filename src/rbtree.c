@@ -1,13 +1,18 @@
 #include "rbtree.h"
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
 
 rbtree *new_rbtree(void)
 {
   rbtree *t = (rbtree *)calloc(1, sizeof(rbtree));
   node_t *nil = (node_t *)calloc(1, sizeof(node_t));
   t->root = t->nil = nil;    // 트리의 nill과 루트를 nil 노드로 설정
+  t->min = t->max = nil;
   nil->color = RBTREE_BLACK; // nil 노드는 항상 검은색
 
   return t;
@@ -24,13 +29,268 @@ void free_node(rbtree *t, node_t *node)
   node = NULL;
 }
 
+// Fibonacci hashing: 키에 2^64 / 황금비를 곱한 값의 상위 bits 비트 (쓰기 버퍼 filter, hash index)
+static size_t fib_hash(const key_t key, const int bits)
+{
+  return (size_t)(((uint64_t)(uint32_t)key * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+/*
+ * 쓰기 버퍼 (선택)
+ *
+ * 삽입/삭제를 바로 트리에 반영하지 않고 키 순서로 정렬된 작은 배열에 모아 둔다.
+ * 같은 키에 대한 변경은 하나의 항목으로 합쳐 delta(삽입 수 - 삭제 수)로 기록하고,
+ * delta가 음수인 항목이 삭제 tombstone이다.
+ * 버퍼가 가득 차거나 읽기가 버퍼의 내용을 필요로 할 때 키 순서대로 한꺼번에 반영한다.
+ */
+
+typedef struct
+{
+  key_t key;
+  int delta;
+} wbuf_entry_t;
+
+#define WBUF_FILTER_LOG 10
+#define WBUF_FILTER_BITS (1 << WBUF_FILTER_LOG)
+
+struct rbtree_wbuf
+{
+  wbuf_entry_t *entries; // 키 순서로 정렬
+  size_t size, cap;
+  // 버퍼에 들어온 적이 있는 키의 hash bitmap (flush 때 비움)
+  // 읽기는 대부분 여기서 걸러져 이진 탐색의 분기 예측 실패를 피한다
+  uint64_t filter[WBUF_FILTER_BITS / 64];
+};
+
+static size_t wbuf_filter_bit(const key_t key)
+{
+  return fib_hash(key, WBUF_FILTER_LOG);
+}
+
+// key 이상인 첫 항목의 위치
+static size_t wbuf_lower_bound(const struct rbtree_wbuf *wbuf, const key_t key)
+{
+  size_t lo = 0, hi = wbuf->size;
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2;
+    if (wbuf->entries[mid].key < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static bool wbuf_pending(const rbtree *t)
+{
+  return t->wbuf != NULL && t->wbuf->size > 0;
+}
+
+static bool wbuf_contains(const rbtree *t, const key_t key)
+{
+  if (!wbuf_pending(t))
+    return false;
+  const size_t bit = wbuf_filter_bit(key);
+  if (!(t->wbuf->filter[bit / 64] & ((uint64_t)1 << (bit % 64))))
+    return false;
+  size_t i = wbuf_lower_bound(t->wbuf, key);
+  return i < t->wbuf->size && t->wbuf->entries[i].key == key;
+}
+
+// 버퍼를 보는 읽기 함수는 여기서 트리를 다시 만들 수 있으므로 const rbtree *를 받지 않는다
+static void wbuf_sync(rbtree *t)
+{
+  if (wbuf_pending(t))
+    rbtree_flush(t);
+}
+
+static void buffer_free(rbtree *t)
+{
+  if (t->wbuf == NULL)
+    return;
+  free(t->wbuf->entries);
+  free(t->wbuf);
+  t->wbuf = NULL;
+}
+
+// intrusive 트리는 노드를 호출한 쪽이 소유하므로 노드를 해제하지 않음
+rbtree *new_rbtree_intrusive(void)
+{
+  rbtree *t = new_rbtree();
+  t->intrusive = 1;
+  return t;
+}
+
 void delete_rbtree(rbtree *t)
 {
-  free_node(t, t->root);
+  rbtree_index_disable(t);
+  buffer_free(t);
+  if (!t->intrusive)
+    free_node(t, t->root);
   free(t->nil);
   free(t);
 }
 
+/*
+ * 정확한 키 탐색을 위한 hash index (선택)
+ *
+ * key -> node_t * 를 open addressing (linear probing) 으로 저장한다.
+ * multiset이어도 키마다 slot은 하나이고, 그 키를 가진 노드 중 아무거나 하나를 가리킨다.
+ * 같은 키의 노드는 중위 순회에서 연속하므로, 가리키던 노드가 지워지면 이웃 노드로 바꾼다.
+ * 삭제는 tombstone 없이 뒤의 slot들을 당겨오는 방식(backward shift)으로 처리한다.
+ */
+
+typedef struct
+{
+  key_t key;
+  node_t *node; // NULL이면 빈 slot
+} index_slot_t;
+
+struct rbtree_index
+{
+  index_slot_t *slots;
+  size_t size;
+  int bits; // slot 수 = 2^bits
+};
+
+static size_t index_hash(const struct rbtree_index *index, const key_t key)
+{
+  return fib_hash(key, index->bits);
+}
+
+static void index_put(struct rbtree_index *index, node_t *node)
+{
+  const size_t mask = ((size_t)1 << index->bits) - 1;
+  size_t i = index_hash(index, node->key);
+  while (index->slots[i].node != NULL)
+    i = (i + 1) & mask;
+  index->slots[i] = (index_slot_t){node->key, node};
+  index->size++;
+}
+
+static node_t *index_find(const struct rbtree_index *index, const key_t key)
+{
+  const size_t mask = ((size_t)1 << index->bits) - 1;
+  for (size_t i = index_hash(index, key); index->slots[i].node != NULL; i = (i + 1) & mask)
+    if (index->slots[i].key == key)
+      return index->slots[i].node;
+  return NULL;
+}
+
+// slot 수를 2^bits로 바꾸고 기존 항목을 다시 넣음
+static int index_resize(struct rbtree_index *index, int bits)
+{
+  index_slot_t *old = index->slots;
+  const size_t old_cap = old ? (size_t)1 << index->bits : 0;
+
+  index->slots = (index_slot_t *)calloc((size_t)1 << bits, sizeof(index_slot_t));
+  if (index->slots == NULL)
+  {
+    index->slots = old;
+    return -1;
+  }
+  index->bits = bits;
+  index->size = 0;
+  for (size_t i = 0; i < old_cap; i++)
+    if (old[i].node != NULL)
+      index_put(index, old[i].node);
+  free(old);
+  return 0;
+}
+
+// node의 키가 처음 들어올 때만 slot 추가 (실패 시 -1)
+// load factor가 3/4를 넘지 않도록 유지
+static int index_add(struct rbtree_index *index, node_t *node)
+{
+  if (index_find(index, node->key) != NULL)
+    return 0;
+  if ((index->size + 1) * 4 > ((size_t)3 << index->bits) && index_resize(index, index->bits + 1) != 0)
+    return -1;
+  index_put(index, node);
+  return 0;
+}
+
+// node를 가리키는 slot을 같은 키의 노드 next로 바꾸거나, next가 NULL이면 slot을 지움
+static void index_remove(struct rbtree_index *index, node_t *node, node_t *next)
+{
+  const size_t mask = ((size_t)1 << index->bits) - 1;
+  size_t i = index_hash(index, node->key);
+  while (index->slots[i].node != node)
+  {
+    if (index->slots[i].node == NULL)
+      return;
+    i = (i + 1) & mask;
+  }
+  if (next != NULL)
+  {
+    index->slots[i].node = next;
+    return;
+  }
+
+  // i 뒤의 항목 중 i 자리로 옮겨도 탐색 경로가 끊기지 않는 항목을 당겨옴
+  for (size_t j = (i + 1) & mask; index->slots[j].node != NULL; j = (j + 1) & mask)
+  {
+    size_t home = index_hash(index, index->slots[j].key);
+    // home이 (i, j] 구간 밖에 있으면 i로 옮길 수 있음
+    if (((j - home) & mask) >= ((j - i) & mask))
+    {
+      index->slots[i] = index->slots[j];
+      i = j;
+    }
+  }
+  index->slots[i].node = NULL;
+  index->size--;
+}
+
+static int index_add_subtree(rbtree *t, node_t *node)
+{
+  if (node == t->nil)
+    return 0;
+  if (index_add(t->index, node) != 0)
+    return -1;
+  if (index_add_subtree(t, node->left) != 0)
+    return -1;
+  return index_add_subtree(t, node->right);
+}
+
+// hash index를 켜고 이미 있는 노드들을 등록 (성공 시 0)
+int rbtree_index_enable(rbtree *t)
+{
+  if (t->index != NULL)
+    return 0;
+  t->index = (struct rbtree_index *)calloc(1, sizeof(struct rbtree_index));
+  if (t->index == NULL || index_resize(t->index, 4) != 0)
+  {
+    free(t->index);
+    t->index = NULL;
+    return -1;
+  }
+  if (index_add_subtree(t, t->root) != 0)
+  {
+    rbtree_index_disable(t);
+    return -1;
+  }
+  return 0;
+}
+
+void rbtree_index_disable(rbtree *t)
+{
+  if (t->index == NULL)
+    return;
+  free(t->index->slots);
+  free(t->index);
+  t->index = NULL;
+}
+
+// hash index가 차지하는 메모리 (byte)
+size_t rbtree_index_memory(const rbtree *t)
+{
+  if (t->index == NULL)
+    return 0;
+  return sizeof(struct rbtree_index) + sizeof(index_slot_t) * ((size_t)1 << t->index->bits);
+}
+
 typedef enum
 {
   LEFT,
@@ -148,11 +408,40 @@ void rbtree_insert_fixup(rbtree *t, node_t *node)
   }
 }
 
-// 의사 코드 기반 노드 삽입 구현
-node_t *rbtree_insert(rbtree *t, const key_t key)
+// 새 노드를 parent의 자식으로 연결하고 불균형 복구
+// hash index를 늘리지 못하면 트리를 바꾸지 않고 NULL 반환
+static node_t *insert_at(rbtree *t, node_t *parent, node_t *new_node)
+{
+  if (t->index != NULL && index_add(t->index, new_node) != 0)
+    return NULL;
+  *new_node = (node_t){RBTREE_RED, new_node->key, parent, t->nil, t->nil};
+
+  if (parent == t->nil)
+    t->root = t->min = t->max = new_node; // 트리가 비어있으면 새 노드를 트리의 루트로 지정
+  else if (new_node->key < parent->key)
+  {
+    parent->left = new_node; // 새 노드를 왼쪽 자식으로 추가
+    if (parent == t->min)
+      t->min = new_node;
+  }
+  else
+  {
+    parent->right = new_node; // 새 노드를 오른쪽 자식으로 추가
+    if (parent == t->max)
+      t->max = new_node;
+  }
+
+  // 불균형 복구
+  rbtree_insert_fixup(t, new_node);
+
+  return new_node;
+}
+
+// current를 루트로 하는 부분 트리에서 삽입 위치를 찾아 삽입
+static node_t *insert_from(rbtree *t, node_t *current, node_t *new_node)
 {
   node_t *parent = t->nil;
-  node_t *current = t->root;
+  const key_t key = new_node->key;
 
   // 새 노드를 삽입할 위치 탐색
   while (current != t->nil)
@@ -164,26 +453,42 @@ node_t *rbtree_insert(rbtree *t, const key_t key)
       current = current->right;
   }
 
-  // 새 노드 생성
-  node_t *new_node = (node_t *)malloc(sizeof(node_t));
-  *new_node = (node_t){RBTREE_RED, key, parent, t->nil, t->nil};
-
-  if (parent == t->nil)
-    t->root = new_node; // 트리가 비어있으면 새 노드를 트리의 루트로 지정
-  else if (new_node->key < parent->key)
-    parent->left = new_node; // 새 노드를 왼쪽 자식으로 추가
-  else
-    parent->right = new_node; // 새 노드를 오른쪽 자식으로 추가
+  return insert_at(t, parent, new_node);
+}
 
-  // 불균형 복구
-  rbtree_insert_fixup(t, new_node);
+static node_t *alloc_node(const key_t key)
+{
+  node_t *new_node = (node_t *)malloc(sizeof(node_t));
+  new_node->key = key;
+  return new_node;
+}
 
+// 의사 코드 기반 노드 삽입 구현
+// intrusive 트리에서는 노드를 할당하지 않으므로 NULL 반환
+node_t *rbtree_insert(rbtree *t, const key_t key)
+{
+  if (t->intrusive)
+    return NULL;
+  node_t *new_node = alloc_node(key);
+  if (insert_from(t, t->root, new_node) == NULL)
+  {
+    free(new_node);
+    return NULL;
+  }
   return new_node;
 }
 
-node_t *rbtree_find(const rbtree *t, const key_t key)
+// 호출한 쪽이 키를 채워서 넘긴 노드를 할당 없이 그대로 연결 (intrusive 모드)
+// 일반 트리는 노드를 free하므로 호출한 쪽의 노드를 받지 않고 NULL 반환
+node_t *rbtree_insert_node(rbtree *t, node_t *node)
+{
+  if (!t->intrusive)
+    return NULL;
+  return insert_from(t, t->root, node);
+}
+
+static node_t *find_from(const rbtree *t, node_t *current, const key_t key)
 {
-  node_t *current = t->root;
   while (current != t->nil)
   {
     if (current->key == key)
@@ -196,20 +501,295 @@ node_t *rbtree_find(const rbtree *t, const key_t key)
   return NULL;
 }
 
-node_t *rbtree_min(const rbtree *t)
+node_t *rbtree_find(rbtree *t, const key_t key)
 {
-  node_t *current = t->root;
-  while (current->left != t->nil)
-    current = current->left;
-  return current;
+  if (wbuf_contains(t, key))
+    wbuf_sync(t);
+  if (t->index != NULL)
+    return index_find(t->index, key);
+  return find_from(t, t->root, key);
+}
+
+// 트리가 비어있으면 NULL 반환
+node_t *rbtree_min(rbtree *t)
+{
+  // 버퍼의 가장 작은 키가 트리의 최소값보다 크면 최소값은 바뀌지 않음
+  if (wbuf_pending(t) && (t->min == t->nil || t->wbuf->entries[0].key <= t->min->key))
+    wbuf_sync(t);
+  return t->min == t->nil ? NULL : t->min;
 }
 
-node_t *rbtree_max(const rbtree *t)
+node_t *rbtree_max(rbtree *t)
 {
+  if (wbuf_pending(t) && (t->max == t->nil || t->wbuf->entries[t->wbuf->size - 1].key >= t->max->key))
+    wbuf_sync(t);
+  return t->max == t->nil ? NULL : t->max;
+}
+
+static node_t *subtree_min(const rbtree *t, node_t *node)
+{
+  while (node->left != t->nil)
+    node = node->left;
+  return node;
+}
+
+static node_t *subtree_max(const rbtree *t, node_t *node)
+{
+  while (node->right != t->nil)
+    node = node->right;
+  return node;
+}
+
+// 중위 순회 기준 다음 노드 (없으면 t->nil)
+static node_t *successor(const rbtree *t, node_t *node)
+{
+  if (node->right != t->nil)
+    return subtree_min(t, node->right);
+  node_t *parent = node->parent;
+  while (parent != t->nil && node == parent->right)
+  {
+    node = parent;
+    parent = parent->parent;
+  }
+  return parent;
+}
+
+// 중위 순회 기준 이전 노드 (없으면 t->nil)
+static node_t *predecessor(const rbtree *t, node_t *node)
+{
+  if (node->left != t->nil)
+    return subtree_max(t, node->left);
+  node_t *parent = node->parent;
+  while (parent != t->nil && node == parent->left)
+  {
+    node = parent;
+    parent = parent->parent;
+  }
+  return parent;
+}
+
+// hint에서 출발해 key가 속하는 범위를 가진 부분 트리가 나올 때까지 올라가고,
+// 내려가며 탐색을 시작할 노드를 반환
+// 올라오면서 key 쪽으로 넘어선 조상만 기억하므로 올라온 경로를 다시 내려가지 않음
+static node_t *climb(const rbtree *t, node_t *node, const key_t key)
+{
+  node_t *start = node;
+  if (key >= node->key)
+  {
+    // 왼쪽 자식에서 올라간 부모의 키가 key보다 크면 그 부모가 상한이므로 멈춤
+    // start의 오른쪽 자식 키가 key보다 크면 key는 start의 오른쪽 부분 트리 안에 있으므로 멈춤
+    for (; start->right == t->nil || start->right->key <= key; node = node->parent)
+    {
+      if (node->parent == t->nil)
+        break;
+      if (node == node->parent->left)
+      {
+        if (node->parent->key > key)
+          break;
+        start = node->parent; // key는 이 부모의 오른쪽 부분 트리에 속함
+      }
+    }
+  }
+  else
+  {
+    // 대칭: 오른쪽 자식에서 올라간 부모의 키가 key보다 작으면 멈춤
+    for (; start->left == t->nil || start->left->key > key; node = node->parent)
+    {
+      if (node->parent == t->nil)
+        break;
+      if (node == node->parent->right)
+      {
+        if (node->parent->key < key)
+          break;
+        start = node->parent; // key는 이 부모의 왼쪽 부분 트리에 속함
+      }
+    }
+  }
+  return start;
+}
+
+// hint 근처에 new_node를 삽입 (hint는 트리 안의 노드, 예: 마지막으로 삽입한 노드)
+// 정렬된 입력은 최대/최소값 옆에 바로 연결하고, 거의 정렬된 입력은 hint와의 거리만큼만 탐색
+static node_t *insert_hint(rbtree *t, node_t *hint, node_t *new_node)
+{
+  const key_t key = new_node->key;
+  if (hint == NULL || hint == t->nil)
+    return insert_from(t, t->root, new_node);
+
+  // 최대값의 오른쪽, 최소값의 왼쪽 자식은 항상 비어 있음
+  if (key >= t->max->key)
+    return insert_at(t, t->max, new_node);
+  if (key < t->min->key)
+    return insert_at(t, t->min, new_node);
+
+  return insert_from(t, climb(t, hint, key), new_node);
+}
+
+node_t *rbtree_insert_hint(rbtree *t, node_t *hint, const key_t key)
+{
+  if (t->intrusive)
+    return NULL;
+  node_t *new_node = alloc_node(key);
+  if (insert_hint(t, hint, new_node) == NULL)
+  {
+    free(new_node);
+    return NULL;
+  }
+  return new_node;
+}
+
+node_t *rbtree_insert_node_hint(rbtree *t, node_t *hint, node_t *node)
+{
+  if (!t->intrusive)
+    return NULL;
+  return insert_hint(t, hint, node);
+}
+
+// hint에서 출발하는 finger search (hint와 가까운 key일수록 빠름)
+node_t *rbtree_find_near(rbtree *t, node_t *hint, const key_t key)
+{
+  if (hint == NULL || hint == t->nil || t->index != NULL || wbuf_contains(t, key))
+    return rbtree_find(t, key);
+  if (key < t->min->key || key > t->max->key)
+    return NULL;
+  if (hint->key == key)
+    return hint;
+  return find_from(t, climb(t, hint, key), key);
+}
+
+// 중위 순회 기준 다음/이전 노드 (없으면 NULL)
+node_t *rbtree_next(const rbtree *t, node_t *node)
+{
+  node_t *next = node == t->max ? t->nil : successor(t, node);
+  return next == t->nil ? NULL : next;
+}
+
+node_t *rbtree_prev(const rbtree *t, node_t *node)
+{
+  node_t *prev = node == t->min ? t->nil : predecessor(t, node);
+  return prev == t->nil ? NULL : prev;
+}
+
+// key 이상인 첫 노드 (없으면 NULL)
+node_t *rbtree_lower_bound(rbtree *t, const key_t key)
+{
+  wbuf_sync(t);
   node_t *current = t->root;
-  while (current->right != t->nil)
-    current = current->right;
-  return current;
+  node_t *found = NULL;
+  while (current != t->nil)
+  {
+    if (current->key >= key)
+    {
+      found = current;
+      current = current->left;
+    }
+    else
+      current = current->right;
+  }
+  return found;
+}
+
+/*
+ * 여러 트리를 하나의 정렬된 순서로 순회하는 cursor
+ *
+ * 트리마다 현재 위치(pos)를 두고, 현재 위치의 키가 작은 트리가 위로 오도록
+ * 트리 번호를 min-heap으로 관리한다. next는 heap의 top을 반환하고 그 트리만 한 칸 전진한다.
+ */
+
+struct rbtree_cursor
+{
+  rbtree **trees;
+  node_t **pos;  // 트리별 현재 위치 (끝나면 NULL)
+  size_t *heap;  // 트리 번호의 min-heap
+  size_t n, heap_size;
+};
+
+// 키가 같으면 트리 번호 순서
+static bool cursor_less(const rbtree_cursor *c, size_t a, size_t b)
+{
+  const key_t ka = c->pos[a]->key, kb = c->pos[b]->key;
+  return ka < kb || (ka == kb && a < b);
+}
+
+static void cursor_sift_down(rbtree_cursor *c, size_t i)
+{
+  size_t tree = c->heap[i];
+  while (2 * i + 1 < c->heap_size)
+  {
+    size_t child = 2 * i + 1;
+    if (child + 1 < c->heap_size && cursor_less(c, c->heap[child + 1], c->heap[child]))
+      child++;
+    if (!cursor_less(c, c->heap[child], tree))
+      break;
+    c->heap[i] = c->heap[child];
+    i = child;
+  }
+  c->heap[i] = tree;
+}
+
+// pos가 채워진 트리들로 heap 재구성
+static void cursor_heapify(rbtree_cursor *c)
+{
+  c->heap_size = 0;
+  for (size_t i = 0; i < c->n; i++)
+    if (c->pos[i] != NULL)
+      c->heap[c->heap_size++] = i;
+  for (size_t i = c->heap_size / 2; i-- > 0;)
+    cursor_sift_down(c, i);
+}
+
+// n개 트리의 전체 최소값에 위치한 cursor 생성 (트리 배열은 복사해 둠)
+rbtree_cursor *rbtree_cursor_open(rbtree *const *trees, const size_t n)
+{
+  rbtree_cursor *c = (rbtree_cursor *)calloc(1, sizeof(rbtree_cursor));
+  c->trees = (rbtree **)malloc(sizeof(rbtree *) * n);
+  c->pos = (node_t **)malloc(sizeof(node_t *) * n);
+  c->heap = (size_t *)malloc(sizeof(size_t) * n);
+  c->n = n;
+  for (size_t i = 0; i < n; i++)
+  {
+    // 버퍼에 남은 변경은 cursor가 열려 있는 동안 반영되지 않으므로 먼저 병합
+    wbuf_sync(trees[i]);
+    c->trees[i] = trees[i];
+    c->pos[i] = rbtree_min(trees[i]);
+  }
+  cursor_heapify(c);
+  return c;
+}
+
+// 다음 next가 key 이상인 첫 키를 반환하도록 이동
+void rbtree_cursor_seek(rbtree_cursor *c, const key_t key)
+{
+  for (size_t i = 0; i < c->n; i++)
+    c->pos[i] = rbtree_lower_bound(c->trees[i], key);
+  cursor_heapify(c);
+}
+
+// 전체 순서상 다음 노드를 반환 (끝이면 NULL). tree가 NULL이 아니면 노드가 속한 트리 번호 저장
+node_t *rbtree_cursor_next(rbtree_cursor *c, size_t *tree)
+{
+  if (c->heap_size == 0)
+    return NULL;
+
+  size_t top = c->heap[0];
+  node_t *node = c->pos[top];
+  if (tree != NULL)
+    *tree = top;
+
+  c->pos[top] = rbtree_next(c->trees[top], node);
+  if (c->pos[top] == NULL)
+    c->heap[0] = c->heap[--c->heap_size];
+  if (c->heap_size > 0)
+    cursor_sift_down(c, 0);
+  return node;
+}
+
+void rbtree_cursor_close(rbtree_cursor *c)
+{
+  free(c->heap);
+  free(c->pos);
+  free(c->trees);
+  free(c);
 }
 
 void rbtree_erase_fixup(rbtree *t, node_t *x)
@@ -307,65 +887,94 @@ void rbtree_erase_fixup(rbtree *t, node_t *x)
   x->color = RBTREE_BLACK;
 }
 
-// 노드를 삭제하는 함수
-int rbtree_erase(rbtree *t, node_t *delete)
+// u 자리에 v를 연결 (v가 nil이어도 부모를 기록해 두어 erase_fixup에서 사용)
+static void transplant(rbtree *t, node_t *u, node_t *v)
 {
-  node_t *remove; // 트리에서 없어질 노드
-  node_t *remove_parent;
-  node_t *remove_child; // 대체노드에 연결된 노드
-  int is_black, is_left;
+  if (u->parent == t->nil)
+    t->root = v;
+  else if (u == u->parent->left)
+    u->parent->left = v;
+  else
+    u->parent->right = v;
+  v->parent = u->parent;
+}
+
+// 노드를 트리에서 떼어내는 함수 (메모리는 해제하지 않음)
+// 자식이 둘인 경우에도 키를 복사하지 않고 후계자 노드를 delete 자리로 옮기므로
+// 삭제되지 않은 다른 노드의 포인터는 계속 유효하다 (rbtree_insert_hint의 hint, intrusive 노드 등)
+static void erase_node(rbtree *t, node_t *delete)
+{
+  node_t *remove = delete; // 트리에서 실제로 빠지는 자리의 노드
+  node_t *remove_child;    // remove 자리를 대신하는 노드
+  color_t remove_color = remove->color;
+
+  // slot이 다른 같은 키의 노드를 가리키면 그대로 둠
+  if (t->index != NULL && index_find(t->index, delete->key) == delete)
+  {
+    // 같은 키의 노드는 연속하므로 남는 노드가 있다면 바로 앞이나 뒤에 있음
+    node_t *next = rbtree_next(t, delete);
+    if (next == NULL || next->key != delete->key)
+      next = rbtree_prev(t, delete);
+    if (next != NULL && next->key != delete->key)
+      next = NULL;
+    index_remove(t->index, delete, next);
+  }
+  if (delete == t->min)
+    t->min = successor(t, delete);
+  if (delete == t->max)
+    t->max = predecessor(t, delete);
 
   // 자식이 없거나 하나만 있는 경우
   if (delete->left == t->nil)
   {
-    remove = delete;
-    remove_child = remove->right;
+    remove_child = delete->right;
+    transplant(t, delete, remove_child);
   }
   else if (delete->right == t->nil)
   {
-    remove = delete;
-    remove_child = remove->left;
+    remove_child = delete->left;
+    transplant(t, delete, remove_child);
   }
-  // 자식이 둘인 경우: delete의 키를 후계자 노드의 키값으로 대체, 노드의 색은 delete의 색 유지
+  // 자식이 둘인 경우: 후계자 노드를 delete 자리로 옮기고 색은 delete의 색 유지
   else
   {
-    rbtree *remove_subtree = (rbtree *)calloc(1, sizeof(rbtree));
-    remove_subtree->root = delete->right; // 오른쪽에 min값
-    // remove_subtree->root = delete->left; //왼쪽에 max값
-    remove_subtree->nil = t->nil;        // rbtree_min의 반복문 종료조건을 만족해주기 위해서
-    remove = rbtree_min(remove_subtree); // 오른쪽에 min값
-    // remove = rbtree_max(remove_subtree); //왼쪽에 max값
-    remove_child = remove->right; // 대체할 노드: 지워질 노드인 후계자는 항상 왼쪽 자식이 없기 때문에, 자식이 있다면 오른쪽 자식 하나뿐임
-    delete->key = remove->key;    // delete의 키를 후계자 노드의 키값으로 대체 (색은 변경 X)
-    free(remove_subtree);
-  }
-
-  // remove 노드 제거하기
-  // remove 노드가 루트인 경우
-  if (remove == t->root)
-  {
-    t->root = remove_child;        // 대체할 노드를 트리의 루트로 지정
-    t->root->color = RBTREE_BLACK; // 루트 노드는 항상 BLACK
-    free(remove);
-    return 0; // 불균형 복구 함수 호출 불필요 (제거 전 트리에 노드가 하나 혹은 두개이므로 불균형이 발생하지 않음)
+    remove = subtree_min(t, delete->right);
+    remove_color = remove->color;
+    remove_child = remove->right; // 후계자는 항상 왼쪽 자식이 없기 때문에, 자식이 있다면 오른쪽 자식 하나뿐임
+    if (remove->parent == delete)
+      remove_child->parent = remove;
+    else
+    {
+      transplant(t, remove, remove_child);
+      remove->right = delete->right;
+      remove->right->parent = remove;
+    }
+    transplant(t, delete, remove);
+    remove->left = delete->left;
+    remove->left->parent = remove;
+    remove->color = delete->color;
   }
 
-  remove_parent = remove->parent;
-  is_black = remove->color;                // remove 노드 제거 전에 지워진 노드의 색 저장
-  is_left = remove_parent->left == remove; // remove가 왼쪽자식인지, 오른쪽 자식인지 저장
-
-  // remove의 자식노드와 부모노드를 연결
-  if (is_left) // remove가 왼쪽 자식이었을 경우: remove 부모의 왼쪽에 이어주기
-    remove_parent->left = remove_child;
-  else // remove가 오른쪽 자식이었을 경우: remove 부모의 오른쪽에 이어주기
-    remove_parent->right = remove_child;
+  // 빠진 자리의 노드가 검정 노드인 경우 불균형 복구 함수 호출
+  if (remove_color == RBTREE_BLACK)
+    rbtree_erase_fixup(t, remove_child);
+}
 
-  remove_child->parent = remove_parent;
-  free(remove);
+// intrusive 트리에서 호출한 쪽의 노드를 떼어냄 (일반 트리는 -1 반환, rbtree_erase 사용)
+int rbtree_erase_node(rbtree *t, node_t *delete)
+{
+  if (!t->intrusive)
+    return -1;
+  erase_node(t, delete);
+  return 0;
+}
 
-  // remove 노드가 검정 노드인 경우 불균형 복구 함수 호출
-  if (is_black)
-    rbtree_erase_fixup(t, remove_child);
+// 노드를 삭제하는 함수
+int rbtree_erase(rbtree *t, node_t *delete)
+{
+  erase_node(t, delete);
+  if (!t->intrusive)
+    free(delete);
   return 0;
 }
 
@@ -374,14 +983,489 @@ void inorder(const rbtree *t, node_t *node, key_t *arr, const size_t n, size_t *
   if (*cnt == n || node == t->nil)
     return;
   inorder(t, node->left, arr, n, cnt);
+  if (*cnt == n) // 왼쪽 부분 트리에서 n개를 채운 경우 arr[n]을 넘어서 쓰지 않도록
+    return;
   arr[(*cnt)++] = node->key;
   inorder(t, node->right, arr, n, cnt);
 }
 // 트리를 중위 순회하며 n개의 키를 배열 arr에 저장
-int rbtree_to_array(const rbtree *t, key_t *arr, const size_t n)
+int rbtree_to_array(rbtree *t, key_t *arr, const size_t n)
 {
   size_t cnt = 0;
+  wbuf_sync(t);
   inorder(t, t->root, arr, n, &cnt);
 
   return 0;
 }
+
+// 쓰기 버퍼를 켬 (capacity가 0이면 256개). intrusive 트리에서는 쓸 수 없음
+int rbtree_buffer_enable(rbtree *t, size_t capacity)
+{
+  if (t->intrusive)
+    return -1;
+  if (t->wbuf != NULL)
+    return 0;
+  if (capacity == 0)
+    capacity = 256;
+  t->wbuf = (struct rbtree_wbuf *)calloc(1, sizeof(struct rbtree_wbuf));
+  if (t->wbuf == NULL)
+    return -1;
+  t->wbuf->entries = (wbuf_entry_t *)malloc(sizeof(wbuf_entry_t) * capacity);
+  if (t->wbuf->entries == NULL)
+  {
+    buffer_free(t);
+    return -1;
+  }
+  t->wbuf->cap = capacity;
+  return 0;
+}
+
+// 남은 변경을 반영하고 쓰기 버퍼를 끔
+void rbtree_buffer_disable(rbtree *t)
+{
+  rbtree_flush(t);
+  buffer_free(t);
+}
+
+// 버퍼의 변경을 키 순서대로 트리에 반영
+// 키 순서로 내려가므로 이웃한 키들은 루트에서 내려가는 경로의 앞부분을 캐시에서 공유한다
+void rbtree_flush(rbtree *t)
+{
+  if (!wbuf_pending(t))
+    return;
+
+  // 반영 중에 부르는 find 등이 다시 flush하지 않도록 먼저 비움
+  struct rbtree_wbuf *wbuf = t->wbuf;
+  const size_t size = wbuf->size;
+  wbuf->size = 0;
+  memset(wbuf->filter, 0, sizeof(wbuf->filter));
+
+  for (size_t i = 0; i < size; i++)
+  {
+    const key_t key = wbuf->entries[i].key;
+    for (int d = wbuf->entries[i].delta; d > 0; d--)
+      rbtree_insert(t, key);
+    for (int d = wbuf->entries[i].delta; d < 0; d++)
+    {
+      node_t *p = rbtree_find(t, key);
+      if (p == NULL)
+        break;
+      rbtree_erase(t, p);
+    }
+  }
+}
+
+// key에 대한 delta를 더하고 0이 된 항목은 제거
+static void wbuf_add(rbtree *t, const key_t key, const int delta)
+{
+  struct rbtree_wbuf *wbuf = t->wbuf;
+  size_t i = wbuf_lower_bound(wbuf, key);
+
+  if (i < wbuf->size && wbuf->entries[i].key == key)
+  {
+    wbuf->entries[i].delta += delta;
+    if (wbuf->entries[i].delta == 0)
+    {
+      memmove(wbuf->entries + i, wbuf->entries + i + 1, sizeof(wbuf_entry_t) * (wbuf->size - i - 1));
+      wbuf->size--;
+    }
+    return;
+  }
+
+  // 새 항목이 들어갈 자리가 없으면 먼저 반영
+  if (wbuf->size == wbuf->cap)
+  {
+    rbtree_flush(t);
+    i = 0;
+  }
+  memmove(wbuf->entries + i + 1, wbuf->entries + i, sizeof(wbuf_entry_t) * (wbuf->size - i));
+  wbuf->entries[i] = (wbuf_entry_t){key, delta};
+  wbuf->size++;
+  const size_t bit = wbuf_filter_bit(key);
+  wbuf->filter[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+// key를 버퍼에 삽입 (버퍼가 꺼져 있으면 바로 rbtree_insert). intrusive 트리에서는 -1
+int rbtree_buffer_insert(rbtree *t, const key_t key)
+{
+  if (t->wbuf == NULL)
+    return rbtree_insert(t, key) != NULL ? 0 : -1;
+  wbuf_add(t, key, 1);
+  return 0;
+}
+
+// key를 가진 노드 하나를 삭제하는 tombstone을 기록 (key가 없으면 -1)
+// 반영 시 같은 키를 가진 노드 중 어느 것이 삭제될지는 정해져 있지 않음
+int rbtree_buffer_erase(rbtree *t, const key_t key)
+{
+  if (t->wbuf == NULL)
+  {
+    node_t *p = rbtree_find(t, key);
+    if (p == NULL)
+      return -1;
+    return rbtree_erase(t, p);
+  }
+
+  // 버퍼 안의 삽입을 취소하는 경우에는 트리를 볼 필요가 없음
+  size_t i = wbuf_lower_bound(t->wbuf, key);
+  int delta = i < t->wbuf->size && t->wbuf->entries[i].key == key ? t->wbuf->entries[i].delta : 0;
+  if (delta <= 0)
+  {
+    // 이미 tombstone이 -delta개 있으므로 트리에 key가 -delta + 1개 이상 있어야 삭제 가능
+    node_t *p = t->index != NULL ? index_find(t->index, key) : find_from(t, t->root, key);
+    if (p != NULL)
+    {
+      // p와 같은 키를 가진 노드는 중위 순서로 연속되어 있음
+      int count = 1;
+      for (node_t *q = p; count <= -delta && (q = rbtree_prev(t, q)) != NULL && q->key == key;)
+        count++;
+      for (node_t *q = p; count <= -delta && (q = rbtree_next(t, q)) != NULL && q->key == key;)
+        count++;
+      if (count <= -delta)
+        p = NULL;
+    }
+    if (p == NULL)
+      return -1;
+  }
+  wbuf_add(t, key, -1);
+  return 0;
+}
+
+/*
+ * 병렬 처리 (to_array / delete / check)
+ *
+ * 트리를 깊이 cut에서 잘라 그 아래의 부분 트리(frontier)들을 작업 단위로 삼는다.
+ * cut 위의 노드(spine)는 개수가 적으므로 직렬로 처리한다.
+ * 작업은 스레드마다 deque로 나눠 주고, 자기 deque가 비면 다른 스레드의 deque에서 훔쳐 온다.
+ */
+
+typedef struct
+{
+  node_t *node;
+  const key_t *lo, *hi; // 검증용 키 범위 (NULL이면 제한 없음)
+  size_t size;          // 부분 트리의 노드 수
+  size_t offset;        // to_array에서 부분 트리가 시작할 위치
+  int black_height;     // 검증 결과 (-1이면 위반)
+} subtree_t;
+
+typedef void (*task_fn)(const rbtree *, subtree_t *, void *);
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  size_t head, tail; // 남은 작업 구간 [head, tail)
+} task_deque_t;
+
+typedef struct
+{
+  const rbtree *t;
+  subtree_t *tasks;
+  task_fn fn;
+  void *arg;
+  task_deque_t *deques;
+  int nthreads;
+} task_pool_t;
+
+typedef struct
+{
+  task_pool_t *pool;
+  int id;
+} worker_t;
+
+static int resolve_threads(int nthreads)
+{
+  if (nthreads > 0)
+    return nthreads;
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+// 자기 deque에서는 앞에서부터 꺼낸다 (키 순서대로 처리해 캐시 지역성 유지)
+static bool pool_pop(task_deque_t *dq, size_t *task)
+{
+  bool ok = false;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->head < dq->tail)
+  {
+    *task = dq->head++;
+    ok = true;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return ok;
+}
+
+// 다른 스레드의 deque에서는 뒤에서부터 훔친다
+static bool pool_steal(task_pool_t *pool, int id, size_t *task)
+{
+  for (int i = 1; i < pool->nthreads; i++)
+  {
+    task_deque_t *dq = &pool->deques[(id + i) % pool->nthreads];
+    bool ok = false;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->head < dq->tail)
+    {
+      *task = --dq->tail;
+      ok = true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    if (ok)
+      return true;
+  }
+  return false;
+}
+
+static void *pool_worker(void *arg)
+{
+  worker_t *w = (worker_t *)arg;
+  task_pool_t *pool = w->pool;
+  size_t task;
+
+  // 작업이 새로 생기지 않으므로 모든 deque가 비면 종료
+  while (pool_pop(&pool->deques[w->id], &task) || pool_steal(pool, w->id, &task))
+    pool->fn(pool->t, &pool->tasks[task], pool->arg);
+  return NULL;
+}
+
+// ntasks개의 부분 트리에 fn을 nthreads개의 스레드로 적용
+static void pool_run(const rbtree *t, subtree_t *tasks, size_t ntasks, int nthreads, task_fn fn, void *arg)
+{
+  if (nthreads > (int)ntasks)
+    nthreads = ntasks > 0 ? (int)ntasks : 1;
+
+  task_pool_t pool = {t, tasks, fn, arg, NULL, nthreads};
+  pool.deques = (task_deque_t *)calloc(nthreads, sizeof(task_deque_t));
+  worker_t *workers = (worker_t *)calloc(nthreads, sizeof(worker_t));
+  pthread_t *threads = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+  bool *started = (bool *)calloc(nthreads, sizeof(bool));
+
+  for (int i = 0; i < nthreads; i++)
+  {
+    pthread_mutex_init(&pool.deques[i].lock, NULL);
+    pool.deques[i].head = ntasks * i / nthreads;
+    pool.deques[i].tail = ntasks * (i + 1) / nthreads;
+    workers[i] = (worker_t){&pool, i};
+  }
+
+  // 0번 worker는 호출한 스레드가 맡는다. 스레드 생성에 실패해도 그 몫은 다른 스레드가 훔쳐 간다
+  for (int i = 1; i < nthreads; i++)
+    started[i] = pthread_create(&threads[i], NULL, pool_worker, &workers[i]) == 0;
+  pool_worker(&workers[0]);
+  for (int i = 1; i < nthreads; i++)
+    if (started[i])
+      pthread_join(threads[i], NULL);
+
+  for (int i = 0; i < nthreads; i++)
+    pthread_mutex_destroy(&pool.deques[i].lock);
+  free(started);
+  free(threads);
+  free(workers);
+  free(pool.deques);
+}
+
+// 스레드당 여러 개의 작업이 돌아가도록 자르는 깊이 결정
+static int frontier_depth(int nthreads)
+{
+  int cut = 0;
+  while ((1 << cut) < nthreads * 8 && cut < 16)
+    cut++;
+  return cut;
+}
+
+// 깊이 cut의 노드들을 중위 순서대로 수집 (키 범위도 함께 기록)
+static void collect_frontier(const rbtree *t, node_t *node, int depth, int cut,
+                             const key_t *lo, const key_t *hi, subtree_t *out, size_t *cnt)
+{
+  if (node == t->nil)
+    return;
+  if (depth == cut)
+  {
+    out[(*cnt)++] = (subtree_t){node, lo, hi, 0, 0, 0};
+    return;
+  }
+  collect_frontier(t, node->left, depth + 1, cut, lo, &node->key, out, cnt);
+  collect_frontier(t, node->right, depth + 1, cut, &node->key, hi, out, cnt);
+}
+
+static subtree_t *split_tree(const rbtree *t, int cut, size_t *ntasks)
+{
+  subtree_t *tasks = (subtree_t *)malloc(sizeof(subtree_t) * ((size_t)1 << cut));
+  *ntasks = 0;
+  collect_frontier(t, t->root, 0, cut, NULL, NULL, tasks, ntasks);
+  return tasks;
+}
+
+static size_t count_node(const rbtree *t, const node_t *node)
+{
+  if (node == t->nil)
+    return 0;
+  return count_node(t, node->left) + 1 + count_node(t, node->right);
+}
+
+static void count_task(const rbtree *t, subtree_t *s, void *arg)
+{
+  s->size = count_node(t, s->node);
+}
+
+typedef struct
+{
+  key_t *arr;
+  size_t n;
+} fill_arg_t;
+
+static void fill_task(const rbtree *t, subtree_t *s, void *arg)
+{
+  fill_arg_t *fill = (fill_arg_t *)arg;
+  size_t cnt = s->offset;
+  if (cnt < fill->n)
+    inorder(t, s->node, fill->arr, fill->n, &cnt);
+}
+
+// spine을 중위 순회하며 spine 노드의 키를 기록하고 각 부분 트리의 시작 위치를 계산
+static void place_spine(const rbtree *t, node_t *node, int depth, int cut, key_t *arr, const size_t n,
+                        subtree_t *tasks, size_t *idx, size_t *pos)
+{
+  if (node == t->nil)
+    return;
+  if (depth == cut)
+  {
+    tasks[*idx].offset = *pos;
+    *pos += tasks[(*idx)++].size;
+    return;
+  }
+  place_spine(t, node->left, depth + 1, cut, arr, n, tasks, idx, pos);
+  if (*pos < n)
+    arr[*pos] = node->key;
+  (*pos)++;
+  place_spine(t, node->right, depth + 1, cut, arr, n, tasks, idx, pos);
+}
+
+// rbtree_to_array와 같은 결과를 여러 스레드로 생성 (nthreads <= 0이면 CPU 수만큼)
+int rbtree_to_array_parallel(rbtree *t, key_t *arr, const size_t n, int nthreads)
+{
+  nthreads = resolve_threads(nthreads);
+  if (nthreads == 1)
+    return rbtree_to_array(t, arr, n);
+  wbuf_sync(t);
+
+  int cut = frontier_depth(nthreads);
+  size_t ntasks, idx = 0, pos = 0;
+  subtree_t *tasks = split_tree(t, cut, &ntasks);
+
+  // 1단계: 부분 트리 크기 계산 -> 2단계: 시작 위치 계산 -> 3단계: 각자 위치에 기록
+  pool_run(t, tasks, ntasks, nthreads, count_task, NULL);
+  place_spine(t, t->root, 0, cut, arr, n, tasks, &idx, &pos);
+  fill_arg_t fill = {arr, n};
+  pool_run(t, tasks, ntasks, nthreads, fill_task, &fill);
+
+  free(tasks);
+  return 0;
+}
+
+static void free_task(const rbtree *t, subtree_t *s, void *arg)
+{
+  free_node((rbtree *)t, s->node);
+}
+
+// cut 위의 노드들만 후위 순회로 해제
+static void free_spine(rbtree *t, node_t *node, int depth, int cut)
+{
+  if (node == t->nil || depth == cut)
+    return;
+  free_spine(t, node->left, depth + 1, cut);
+  free_spine(t, node->right, depth + 1, cut);
+  free(node);
+}
+
+// delete_rbtree와 같지만 노드 해제를 여러 스레드로 수행
+void delete_rbtree_parallel(rbtree *t, int nthreads)
+{
+  nthreads = resolve_threads(nthreads);
+  if (nthreads == 1 || t->intrusive)
+  {
+    delete_rbtree(t);
+    return;
+  }
+  rbtree_index_disable(t);
+  buffer_free(t);
+
+  int cut = frontier_depth(nthreads);
+  size_t ntasks;
+  subtree_t *tasks = split_tree(t, cut, &ntasks);
+  pool_run(t, tasks, ntasks, nthreads, free_task, NULL);
+  free(tasks);
+
+  free_spine(t, t->root, 0, cut);
+  free(t->nil);
+  free(t);
+}
+
+// node를 루트로 하는 부분 트리의 black height 반환 (RB 트리 조건 위반 시 -1)
+// depth == cut인 노드는 이미 검증된 tasks의 결과를 사용
+static int check_node(const rbtree *t, const node_t *node, const key_t *lo, const key_t *hi,
+                      int depth, int cut, const subtree_t *tasks, size_t *idx)
+{
+  if (node == t->nil)
+    return 1;
+  if (depth == cut)
+    return tasks[(*idx)++].black_height;
+
+  // 탐색 트리 조건
+  if ((lo && node->key < *lo) || (hi && node->key > *hi))
+    return -1;
+  // 부모 포인터
+  if ((node->left != t->nil && node->left->parent != node) ||
+      (node->right != t->nil && node->right->parent != node))
+    return -1;
+  // RED 노드의 자식은 BLACK
+  if (node->color == RBTREE_RED &&
+      (node->left->color == RBTREE_RED || node->right->color == RBTREE_RED))
+    return -1;
+
+  int lh = check_node(t, node->left, lo, &node->key, depth + 1, cut, tasks, idx);
+  int rh = check_node(t, node->right, &node->key, hi, depth + 1, cut, tasks, idx);
+  if (lh < 0 || rh != lh)
+    return -1;
+  return lh + (node->color == RBTREE_BLACK);
+}
+
+static void check_task(const rbtree *t, subtree_t *s, void *arg)
+{
+  s->black_height = check_node(t, s->node, s->lo, s->hi, 0, -1, NULL, NULL);
+}
+
+// 루트와 min/max 캐시 확인
+static int check_root(const rbtree *t)
+{
+  if (t->nil->color != RBTREE_BLACK || t->root->color != RBTREE_BLACK)
+    return 0;
+  if (t->root == t->nil)
+    return t->min == t->nil && t->max == t->nil;
+  return t->root->parent == t->nil &&
+         t->min == subtree_min(t, t->root) && t->max == subtree_max(t, t->root);
+}
+
+// RB 트리 조건을 모두 만족하면 1, 아니면 0
+int rbtree_check(const rbtree *t)
+{
+  if (!check_root(t))
+    return 0;
+  return check_node(t, t->root, NULL, NULL, 0, -1, NULL, NULL) >= 0;
+}
+
+int rbtree_check_parallel(const rbtree *t, int nthreads)
+{
+  nthreads = resolve_threads(nthreads);
+  if (nthreads == 1)
+    return rbtree_check(t);
+  if (!check_root(t))
+    return 0;
+
+  int cut = frontier_depth(nthreads);
+  size_t ntasks, idx = 0;
+  subtree_t *tasks = split_tree(t, cut, &ntasks);
+  pool_run(t, tasks, ntasks, nthreads, check_task, NULL);
+  int ok = check_node(t, t->root, NULL, NULL, 0, cut, tasks, &idx) >= 0;
+
+  free(tasks);
+  return ok;
+}
@@ -16,17 +16,84 @@ typedef struct node_t {
 typedef struct rbtree {
   node_t *root;
   node_t *nil;  // for sentinel
+  node_t *min, *max;  // cached leftmost/rightmost node (nil if empty)
+  int intrusive;      // nodes are owned by the caller
+  struct rbtree_index *index;  // optional key -> node hash index
+  struct rbtree_wbuf *wbuf;    // optional write buffer
 } rbtree;
 
+// get the struct that embeds a node_t, e.g. rbtree_entry(p, struct item, link)
+#define rbtree_entry(ptr, type, member) \
+  ((type *)((char *)(ptr) - offsetof(type, member)))
+
 rbtree *new_rbtree(void);
+// the tree never allocates or frees nodes: use rbtree_insert_node with a
+// node embedded in the caller's struct, and rbtree_erase_node to unlink it.
+// The allocating inserts (rbtree_insert, rbtree_insert_hint,
+// rbtree_buffer_insert) refuse such a tree and return NULL / -1, and the
+// link/unlink calls below refuse a tree from new_rbtree the same way.
+rbtree *new_rbtree_intrusive(void);
 void delete_rbtree(rbtree *);
 
 node_t *rbtree_insert(rbtree *, const key_t);
-node_t *rbtree_find(const rbtree *, const key_t);
-node_t *rbtree_min(const rbtree *);
-node_t *rbtree_max(const rbtree *);
+node_t *rbtree_find(rbtree *, const key_t);
+node_t *rbtree_min(rbtree *);
+node_t *rbtree_max(rbtree *);
 int rbtree_erase(rbtree *, node_t *);
 
-int rbtree_to_array(const rbtree *, key_t *, const size_t);
+// link/unlink a caller-owned node (key must be set before insertion);
+// intrusive trees only, NULL / -1 otherwise
+node_t *rbtree_insert_node(rbtree *, node_t *);
+int rbtree_erase_node(rbtree *, node_t *);
+
+// start the search from hint (a node in the tree, e.g. the last inserted one);
+// appends at either end take O(1) and keys close to hint take a short climb,
+// but a random stream is better served by rbtree_insert/rbtree_find
+node_t *rbtree_insert_hint(rbtree *, node_t *hint, const key_t);
+node_t *rbtree_insert_node_hint(rbtree *, node_t *hint, node_t *);
+node_t *rbtree_find_near(rbtree *, node_t *hint, const key_t);
+
+// optional hash index: rbtree_find becomes a hash lookup, while ordered
+// operations keep using the tree. It holds one entry per distinct key, so
+// duplicates cost nothing extra. Inserts return NULL if it cannot grow.
+int rbtree_index_enable(rbtree *);
+void rbtree_index_disable(rbtree *);
+size_t rbtree_index_memory(const rbtree *);
+
+// optional write buffer: buffered inserts/erases are merged into the tree
+// in sorted batches when the buffer fills or a read depends on them.
+// find/find_near/min/max/lower_bound/to_array(_parallel) and
+// rbtree_cursor_open see every buffered change by flushing first, which
+// modifies the tree: that is why they take a non-const tree, and they must
+// not run concurrently on one tree while its buffer is enabled. next/prev
+// walk the tree as it is.
+int rbtree_buffer_enable(rbtree *, size_t capacity);
+void rbtree_buffer_disable(rbtree *);
+int rbtree_buffer_insert(rbtree *, const key_t);
+int rbtree_buffer_erase(rbtree *, const key_t);
+void rbtree_flush(rbtree *);
+
+// in-order neighbours, NULL past the ends
+node_t *rbtree_next(const rbtree *, node_t *);
+node_t *rbtree_prev(const rbtree *, node_t *);
+// first node with a key >= the given key, NULL if none
+node_t *rbtree_lower_bound(rbtree *, const key_t);
+
+int rbtree_to_array(rbtree *, key_t *, const size_t);
+
+// lazy in-order view over several trees; the trees must not change while
+// the cursor is open
+typedef struct rbtree_cursor rbtree_cursor;
+
+rbtree_cursor *rbtree_cursor_open(rbtree *const *, const size_t n);
+void rbtree_cursor_seek(rbtree_cursor *, const key_t);
+node_t *rbtree_cursor_next(rbtree_cursor *, size_t *tree);
+void rbtree_cursor_close(rbtree_cursor *);
+
+// nthreads <= 0 uses one thread per online CPU
+int rbtree_to_array_parallel(rbtree *, key_t *, const size_t, int nthreads);
+void delete_rbtree_parallel(rbtree *, int nthreads);
+int rbtree_check(const rbtree *);
+int rbtree_check_parallel(const rbtree *, int nthreads);
 
 #endif  // _RBTREE_H_
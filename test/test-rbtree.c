@@ -367,6 +367,432 @@ void test_find_erase_rand(const size_t n, const unsigned int seed) {
   delete_rbtree(t);
 }
 
+// parallel to_array/check/delete should agree with the serial versions
+void test_parallel(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  for (int i = 0; i < n; i++) {
+    rbtree_insert(t, rand() % (n / 2));
+  }
+
+  key_t *expected = calloc(n, sizeof(key_t));
+  key_t *res = calloc(n, sizeof(key_t));
+  rbtree_to_array(t, expected, n);
+
+  const int threads[] = {1, 2, 3, 8};
+  for (int i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    rbtree_to_array_parallel(t, res, n, threads[i]);
+    for (int j = 0; j < n; j++) {
+      assert(res[j] == expected[j]);
+    }
+    // partial export should stop at the given size
+    res[n / 3] = -1;
+    rbtree_to_array_parallel(t, res, n / 3, threads[i]);
+    assert(res[n / 3] == -1);
+    for (int j = 0; j < n / 3; j++) {
+      assert(res[j] == expected[j]);
+    }
+
+    assert(rbtree_check_parallel(t, threads[i]));
+  }
+  assert(rbtree_check(t));
+
+  // a red node with a red child must be detected
+  node_t *p = rbtree_max(t);
+  node_t *q = p->parent;
+  color_t p_color = p->color, q_color = q->color;
+  p->color = q->color = RBTREE_RED;
+  assert(!rbtree_check(t));
+  assert(!rbtree_check_parallel(t, 4));
+  p->color = p_color;
+  q->color = q_color;
+
+  free(res);
+  free(expected);
+  delete_rbtree_parallel(t, 4);
+}
+
+static void insert_hint_arr(rbtree *t, const key_t *arr, const size_t n) {
+  node_t *hint = NULL;
+  for (size_t i = 0; i < n; i++) {
+    hint = rbtree_insert_hint(t, hint, arr[i]);
+    assert(hint != NULL);
+    assert(hint->key == arr[i]);
+  }
+}
+
+// hinted insert should build the same ordered tree as rbtree_insert, and
+// find_near should find every key from any starting node
+void test_insert_hint(key_t *arr, const size_t n) {
+  rbtree *t = new_rbtree();
+  insert_hint_arr(t, arr, n);
+  assert(rbtree_check(t));
+
+  key_t *res = calloc(n, sizeof(key_t));
+  rbtree_to_array(t, res, n);
+  qsort((void *)arr, n, sizeof(key_t), comp);
+  for (int i = 0; i < n; i++) {
+    assert(arr[i] == res[i]);
+  }
+
+  node_t *hints[] = {rbtree_min(t), rbtree_max(t), t->root,
+                     rbtree_find(t, arr[n / 3])};
+  for (int h = 0; h < sizeof(hints) / sizeof(hints[0]); h++) {
+    for (int i = 0; i < n; i++) {
+      node_t *p = rbtree_find_near(t, hints[h], arr[i]);
+      assert(p != NULL);
+      assert(p->key == arr[i]);
+    }
+    assert(rbtree_find_near(t, hints[h], arr[0] - 1) == NULL);
+    assert(rbtree_find_near(t, hints[h], arr[n - 1] + 1) == NULL);
+    if (arr[n / 2] + 1 < arr[n / 2 + 1]) {
+      assert(rbtree_find_near(t, hints[h], arr[n / 2] + 1) == NULL);
+    }
+  }
+
+  // erasing other nodes should keep the hint valid
+  node_t *hint = rbtree_find(t, arr[n / 2]);
+  for (int i = 0; i < n; i += 2) {
+    node_t *p = rbtree_find_near(t, hint, arr[i]);
+    if (p == hint) {
+      continue;
+    }
+    rbtree_erase(t, p);
+  }
+  assert(hint->key == arr[n / 2]);
+  assert(rbtree_check(t));
+  rbtree_insert_hint(t, hint, arr[n / 2]);
+  rbtree_insert_hint(t, hint, arr[0] - 1);
+  rbtree_insert_hint(t, hint, arr[n - 1] + 1);
+  assert(rbtree_check(t));
+  assert(rbtree_min(t)->key == arr[0] - 1);
+  assert(rbtree_max(t)->key == arr[n - 1] + 1);
+
+  free(res);
+  delete_rbtree(t);
+}
+
+void test_insert_hint_suite() {
+  const size_t n = 10000;
+  key_t *arr = calloc(n, sizeof(key_t));
+
+  // sequential
+  for (int i = 0; i < n; i++) {
+    arr[i] = i;
+  }
+  test_insert_hint(arr, n);
+
+  // reversed
+  for (int i = 0; i < n; i++) {
+    arr[i] = n - i;
+  }
+  test_insert_hint(arr, n);
+
+  // nearly sorted with duplicates
+  srand(29);
+  for (int i = 0; i < n; i++) {
+    arr[i] = i / 2 + rand() % 16;
+  }
+  test_insert_hint(arr, n);
+
+  // random
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % n;
+  }
+  test_insert_hint(arr, n);
+
+  free(arr);
+}
+
+struct item {
+  int payload;
+  node_t link;
+};
+
+// intrusive nodes are linked in place and never freed by the tree
+void test_intrusive(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree_intrusive();
+  struct item *items = calloc(n, sizeof(struct item));
+  for (int i = 0; i < n; i++) {
+    items[i].payload = i;
+    items[i].link.key = rand() % n;
+    node_t *p = rbtree_insert_node(t, &items[i].link);
+    assert(p == &items[i].link);
+  }
+  assert(rbtree_check(t));
+
+  for (int i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, items[i].link.key);
+    assert(p != NULL);
+    struct item *it = rbtree_entry(p, struct item, link);
+    assert(it->link.key == items[i].link.key);
+    assert(&items[it->payload] == it);
+  }
+
+  // unlink every other item, then link them back
+  for (int i = 0; i < n; i += 2) {
+    rbtree_erase_node(t, &items[i].link);
+  }
+  assert(rbtree_check(t));
+  for (int i = 1; i < n; i += 2) {
+    node_t *p = rbtree_find(t, items[i].link.key);
+    assert(p != NULL);
+  }
+  node_t *hint = NULL;
+  for (int i = 0; i < n; i += 2) {
+    hint = rbtree_insert_node_hint(t, hint, &items[i].link);
+  }
+  assert(rbtree_check(t));
+
+  // allocating inserts must not add nodes the tree would never free
+  assert(rbtree_insert(t, 1) == NULL);
+  assert(rbtree_insert_hint(t, hint, 1) == NULL);
+  assert(rbtree_buffer_insert(t, 1) == -1);
+  assert(rbtree_buffer_enable(t, 0) == -1);
+
+  // rbtree_erase must not free a caller-owned node
+  rbtree_erase(t, &items[0].link);
+  assert(items[0].payload == 0);
+  assert(rbtree_check(t));
+
+  // a tree that frees its nodes must not accept caller-owned ones
+  rbtree *owning = new_rbtree();
+  struct item extra = {n, {.key = 1}};
+  assert(rbtree_insert_node(owning, &extra.link) == NULL);
+  assert(rbtree_insert_node_hint(owning, NULL, &extra.link) == NULL);
+  node_t *p = rbtree_insert(owning, 1);
+  assert(rbtree_erase_node(owning, p) == -1);
+  assert(rbtree_find(owning, 1) == p);
+  assert(rbtree_check(owning));
+  delete_rbtree(owning);
+
+  delete_rbtree(t);
+  free(items);
+}
+
+// merged cursor should yield the keys of all trees in global order
+void test_cursor(const size_t ntrees, const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree **trees = calloc(ntrees, sizeof(rbtree *));
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < ntrees; i++) {
+    trees[i] = new_rbtree();
+  }
+  // the last tree stays empty
+  for (int i = 0; i < n; i++) {
+    arr[i] = rand() % (n / 2);
+    rbtree_insert(trees[i % (ntrees - 1)], arr[i]);
+  }
+  qsort((void *)arr, n, sizeof(key_t), comp);
+
+  rbtree_cursor *c = rbtree_cursor_open(trees, ntrees);
+  size_t tree;
+  for (int i = 0; i < n; i++) {
+    node_t *p = rbtree_cursor_next(c, &tree);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+    assert(tree < ntrees - 1);
+  }
+  assert(rbtree_cursor_next(c, &tree) == NULL);
+
+  // seek to an existing key, a missing key and past the end
+  const key_t targets[] = {arr[n / 2], arr[n / 3] + 1, arr[n - 1] + 1, -1};
+  for (int k = 0; k < sizeof(targets) / sizeof(targets[0]); k++) {
+    size_t i = 0;
+    while (i < n && arr[i] < targets[k]) {
+      i++;
+    }
+    rbtree_cursor_seek(c, targets[k]);
+    // stop early after a few keys
+    for (int j = 0; j < 10 && i + j < n; j++) {
+      node_t *p = rbtree_cursor_next(c, NULL);
+      assert(p != NULL);
+      assert(p->key == arr[i + j]);
+    }
+    if (i == n) {
+      assert(rbtree_cursor_next(c, NULL) == NULL);
+    }
+  }
+  rbtree_cursor_close(c);
+
+  for (int i = 0; i < ntrees; i++) {
+    delete_rbtree(trees[i]);
+  }
+  free(arr);
+  free(trees);
+}
+
+// hash index should give the same answers as the tree and follow
+// inserts/erases, including duplicate keys
+void test_index(const size_t n, const unsigned int seed) {
+  srand(seed);
+  rbtree *t = new_rbtree();
+  key_t *arr = calloc(n, sizeof(key_t));
+  for (int i = 0; i < n / 2; i++) {
+    arr[i] = rand() % (n / 4);
+    rbtree_insert(t, arr[i]);
+  }
+  // enable on a non-empty tree, then keep inserting
+  assert(rbtree_index_enable(t) == 0);
+  assert(rbtree_index_memory(t) > 0);
+  for (int i = n / 2; i < n; i++) {
+    arr[i] = rand() % (n / 4);
+    rbtree_insert(t, arr[i]);
+  }
+
+  for (int i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    assert(p->key == arr[i]);
+  }
+  assert(rbtree_find(t, -1) == NULL);
+  assert(rbtree_find(t, n) == NULL);
+
+  // erase every key once; duplicates must stay findable until the last one
+  for (int i = 0; i < n; i++) {
+    node_t *p = rbtree_find(t, arr[i]);
+    assert(p != NULL);
+    rbtree_erase(t, p);
+  }
+  for (int i = 0; i < n; i++) {
+    assert(rbtree_find(t, arr[i]) == NULL);
+  }
+  assert(rbtree_check(t));
+
+  rbtree_index_disable(t);
+  assert(rbtree_index_memory(t) == 0);
+  assert(rbtree_index_enable(t) == 0);
+  test_find_erase(t, arr, n);
+  delete_rbtree(t);
+
+  // many copies of a few keys share one slot per key, and a key stays
+  // findable until its last node is erased, whichever node goes first
+  t = new_rbtree();
+  assert(rbtree_index_enable(t) == 0);
+  const size_t empty_memory = rbtree_index_memory(t);
+  node_t **nodes = calloc(n, sizeof(node_t *));
+  int counts[4] = {0};
+  for (int i = 0; i < n; i++) {
+    nodes[i] = rbtree_insert(t, i % 4);
+    counts[i % 4]++;
+  }
+  assert(rbtree_index_memory(t) == empty_memory);
+  for (int i = n - 1; i > 0; i--) {
+    const int j = rand() % (i + 1);
+    node_t *tmp = nodes[i];
+    nodes[i] = nodes[j];
+    nodes[j] = tmp;
+  }
+  for (int i = 0; i < n; i++) {
+    const key_t key = nodes[i]->key;
+    rbtree_erase(t, nodes[i]);
+    counts[key]--;
+    for (key_t k = 0; k < 4; k++) {
+      node_t *p = rbtree_find(t, k);
+      assert((p != NULL) == (counts[k] > 0));
+      assert(p == NULL || p->key == k);
+    }
+  }
+  assert(rbtree_check(t));
+
+  free(nodes);
+  free(arr);
+  delete_rbtree(t);
+}
+
+// buffered inserts/erases should be visible to find/min/max/to_array and
+// the merged cursor exactly as if they had been applied immediately
+void test_buffer(const size_t n, const unsigned int seed) {
+  const int range = 64;
+  int counts[64] = {0};
+  size_t size = 0;
+  srand(seed);
+  rbtree *t = new_rbtree();
+  assert(rbtree_buffer_enable(t, 16) == 0);
+
+  for (int i = 0; i < n; i++) {
+    const key_t key = rand() % range;
+    if (rand() % 3 != 0) {
+      rbtree_buffer_insert(t, key);
+      counts[key]++;
+      size++;
+    } else if (rbtree_buffer_erase(t, key) == 0) {
+      assert(counts[key] > 0);
+      counts[key]--;
+      size--;
+    } else {
+      assert(counts[key] == 0);
+    }
+
+    if (i % 7 == 0) {
+      const key_t probe = rand() % range;
+      node_t *p = rbtree_find(t, probe);
+      assert((p != NULL) == (counts[probe] > 0));
+    }
+    if (i % 31 == 0 && size > 0) {
+      int lo = 0, hi = range - 1;
+      while (counts[lo] == 0) {
+        lo++;
+      }
+      while (counts[hi] == 0) {
+        hi--;
+      }
+      assert(rbtree_min(t)->key == lo);
+      assert(rbtree_max(t)->key == hi);
+    }
+  }
+
+  key_t *res = calloc(size + 1, sizeof(key_t));
+  rbtree_to_array(t, res, size);
+  size_t j = 0;
+  for (int key = 0; key < range; key++) {
+    for (int c = 0; c < counts[key]; c++) {
+      assert(res[j++] == key);
+    }
+  }
+  assert(rbtree_check(t));
+
+  // erase that cancels a buffered insert of a key the tree never had
+  rbtree_buffer_insert(t, range);
+  assert(rbtree_buffer_erase(t, range) == 0);
+  assert(rbtree_buffer_erase(t, range) == -1);
+  assert(rbtree_find(t, range) == NULL);
+
+  // a cursor opened over pending inserts and tombstones sees them; every
+  // buffered key is above the tree's minimum
+  rbtree *trees[2] = {new_rbtree(), new_rbtree()};
+  const key_t own[] = {1, 3, 5}, other[] = {2, 6}, merged[] = {1, 2, 4, 5, 6, 7};
+  for (int i = 0; i < 3; i++) {
+    rbtree_insert(trees[0], own[i]);
+  }
+  for (int i = 0; i < 2; i++) {
+    rbtree_insert(trees[1], other[i]);
+  }
+  assert(rbtree_buffer_enable(trees[0], 16) == 0);
+  rbtree_buffer_insert(trees[0], 4);
+  assert(rbtree_buffer_erase(trees[0], 3) == 0);
+  rbtree_buffer_insert(trees[0], 7);
+  rbtree_cursor *c = rbtree_cursor_open(trees, 2);
+  for (int i = 0; i < sizeof(merged) / sizeof(merged[0]); i++) {
+    node_t *p = rbtree_cursor_next(c, NULL);
+    assert(p != NULL);
+    assert(p->key == merged[i]);
+  }
+  assert(rbtree_cursor_next(c, NULL) == NULL);
+  rbtree_cursor_close(c);
+  delete_rbtree(trees[0]);
+  delete_rbtree(trees[1]);
+
+  // pending changes are applied when the buffer is turned off
+  rbtree_buffer_insert(t, range + 1);
+  rbtree_buffer_disable(t);
+  assert(rbtree_find(t, range + 1) != NULL);
+
+  free(res);
+  delete_rbtree(t);
+}
+
 int main(void) {
   test_init();
   test_insert_single(1024);
@@ -379,5 +805,12 @@ int main(void) {
   test_duplicate_values();
   test_multi_instance();
   test_find_erase_rand(10000, 17);
+  test_parallel(100000, 23);
+  test_insert_hint_suite();
+  test_intrusive(10000, 37);
+  test_cursor(2, 100, 41);
+  test_cursor(17, 10000, 43);
+  test_index(10000, 53);
+  test_buffer(10000, 61);
   printf("Passed all tests!\n");
 }